@@ -1,15 +1,21 @@
 #include <cassert>
+#include <chrono>
 #include <map>
 #include <optional>
 #include <string>
 #include "raylib.h"
 #include "rlgl.h"
 #include "yaml-cpp/yaml.h"
+#include "autosave.hpp"
+#include "benchmark.hpp"
 #include "config.hpp"
 #include "engine_core.hpp"
+#include "object_layer.hpp"
 #include "ui.hpp"
 #include "callbacks.hpp"
+#include "display_list.hpp"
 #include "drawing.hpp"
+#include "recording.hpp"
 
 /*
 struct Tilemap
@@ -58,24 +64,47 @@ std::optional<Rectangle> get_highlighted_tile(const Vector2 &mouse_point, const
     return Rectangle{.x = x * size, .y = y * size, .width = size, .height = size};
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
-    const std::string config_path = "../resources/config.yaml";
+    const std::optional<recording::Options> parsed_options = recording::parse_arguments(argc, argv);
+    if (not parsed_options.has_value())
+    {
+        printf("Usage: te [--config <overlay.yaml>]... [--record <file> | --replay <file>]\n");
+        return 1;
+    }
+    const recording::Options &options = parsed_options.value();
+
+    YAML::Node config = config::load_config("../resources/config.yaml", options.config_overlays);
 
-    YAML::Node config = YAML::LoadFile(config_path);
+    std::optional<recording::Recording> replay{std::nullopt};
+    if (options.mode == recording::Mode::REPLAY)
+    {
+        replay = recording::load(options.path);
+        if (not replay.has_value())
+        {
+            return 1;
+        }
+        // replay renders offscreen, so it is not limited by the monitor
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    }
 
     InitWindow(0, 0, config["window_name"].as<std::string>().c_str());
     while (not IsWindowReady())
     {
     };
-    if (config["screen"]["fullscreen"].as<bool>())
+    if (config["screen"]["fullscreen"].as<bool>() and not replay.has_value())
     {
         ToggleBorderlessWindowed();
     }
-    const auto [screen_width, screen_height] = config::get_screen_size(config);
+    const auto [screen_width, screen_height] =
+        replay.has_value() ? std::array<int, 2>{replay->screen_width, replay->screen_height}
+                           : config::get_screen_size(config);
     SetWindowSize(screen_width, screen_height);
 
+    benchmark::add_widgets(config, benchmark::get_count(config, "ui_widgets"), screen_width, screen_height);
     auto [layers, ui] = config::load_interface(config, screen_width, screen_height);
+    const bool immediate_ui = benchmark::is_enabled(config, "immediate_ui");
+    display_list::DisplayList ui_display_list = display_list::make_display_list(layers, ui);
     std::map<std::string, Callback> ui_callbacks;
     ui_callbacks["reload_button"] = callbacks::reload_button;
     ui_callbacks["tile_bank_arrow_right"] = callbacks::arrow_right;
@@ -83,27 +112,25 @@ int main(void)
     ui_callbacks["main_area"] = callbacks::main_area;
     ui_callbacks["texture_area"] = callbacks::texture_area;
 
-    Camera2D main_camera = {};
-    main_camera.zoom = 1.0f;
     Camera2D texture_camera = {};
     texture_camera.zoom = 1.0f;
 
     const int tile_size = config["tile_size_px"].as<int>();
-    const Grid main_grid{.x_square_count = config["main_grid"]["count_x"].as<int>(),
-                         .y_square_count = config["main_grid"]["count_y"].as<int>(),
-                         .square_size_px = tile_size * config["main_grid"]["initial_scale"].as<int>()};
-
     const int initial_scale = config["texture_grid"]["initial_scale"].as<int>();
     const int margin = config["texture_grid"]["margin"].as<int>();
 
-    AppState app_state{.main_grid = main_grid,
+    // maps are validated against loaded tilemaps, so textures go first
+    std::vector<Tilemap> tilemaps = config::load_textures(config);
+    std::vector<Document> documents = config::load_documents(config, tilemaps.size(), replay.has_value());
+    AppState app_state{.documents = std::move(documents),
+                       .document_index = 0,
                        .texture_grid = {},
-                       .main_camera = main_camera,
                        .texture_camera = texture_camera,
-                       .tilemaps = config::load_textures(config),
+                       .tilemaps = std::move(tilemaps),
                        .tilemap_index = {},
                        .tile_size = tile_size,
-                       .texture_grid_margin = margin};
+                       .texture_grid_margin = margin,
+                       .selected_tile = std::nullopt};
 
     if (app_state.tilemaps.size() > 0)
     {
@@ -111,12 +138,49 @@ int main(void)
                                   .y_square_count = app_state.tilemaps[0].texture.height / tile_size + 2 * margin,
                                   .square_size_px = tile_size * initial_scale};
     }
+    benchmark::populate_objects(app_state, benchmark::get_count(config, "objects"));
+    autosave::Worker autosave_worker{};
+    autosave::start(autosave_worker);
+    for (const Document &document : app_state.documents)
+    {
+        autosave::open(autosave_worker, document);
+    }
+    if (replay.has_value())
+    {
+        // filling the cache of a large map takes seconds, it must not overlap the measured frames
+        autosave::wait_idle(autosave_worker);
+    }
+
     std::optional<std::string> previously_hovered_item{std::nullopt};
+    objects::VisibleSet visible_objects{};
+
+    const autosave::Settings autosave_settings{
+        .enabled = config["autosave"]["enabled"].as<bool>(),
+        .interval_s = config["autosave"]["interval_s"].as<double>(),
+        .max_dirty_chunks = config["autosave"]["max_dirty_chunks"].as<unsigned>()};
+
+    recording::Recording recorded{.screen_width = screen_width, .screen_height = screen_height, .frames = {}};
+    recording::ReplayStats replay_stats{};
+    const double cpu_time_start = recording::get_cpu_time_s();
+    std::size_t frame = 0;
 
-    SetTargetFPS(60);
+    // replay runs at maximum speed
+    SetTargetFPS(replay.has_value() ? 0 : 60);
     while (!WindowShouldClose())
     {
-        const Inputs inputs = get_inputs();
+        if (replay.has_value() and (frame == replay->frames.size()))
+        {
+            break;
+        }
+        const auto frame_start = std::chrono::steady_clock::now();
+
+        const Inputs inputs = replay.has_value() ? replay->frames[frame] : get_inputs();
+        frame++;
+        if (options.mode == recording::Mode::RECORD)
+        {
+            recorded.frames.push_back(inputs);
+        }
+
         const std::optional<std::string> hovered_item = get_ui_interaction(inputs, layers, ui);
         if (hovered_item.has_value())
         {
@@ -134,26 +198,64 @@ int main(void)
         }
         previously_hovered_item = hovered_item;
 
+        if (inputs.next_document_key_pressed)
+        {
+            app_state.document_index = (app_state.document_index + 1) % app_state.documents.size();
+            visible_objects.valid = false;
+        }
+        // Replay counts time in frames of 60 fps session, so autosaves become due on the same frames in every run.
+        // How many of them start depends on the worker, due save waits while the previous one is still running.
+        const double time_s = replay.has_value() ? static_cast<double>(frame) / 60. : GetTime();
+        const autosave::Activity autosave_activity =
+            autosave::update(autosave_worker, app_state, autosave_settings, time_s);
+        replay_stats.autosave_count += autosave_activity.requested;
+        replay_stats.autosave_postponed_count += autosave_activity.postponed;
+        const Document &document = get_document(app_state);
+
         const Vector2 mouse_point_texture = GetScreenToWorld2D(inputs.mouse_point, app_state.texture_camera);
-        const Vector2 mouse_point_map = GetScreenToWorld2D(inputs.mouse_point, app_state.main_camera);
+        const Vector2 mouse_point_map = GetScreenToWorld2D(inputs.mouse_point, document.main_camera);
         const std::optional<Rectangle> highlighted_texture_tile =
             get_highlighted_tile(mouse_point_texture, app_state.texture_grid);
         const std::optional<Rectangle> highlighted_map_tile =
-            get_highlighted_tile(mouse_point_map, app_state.main_grid);
+            get_highlighted_tile(mouse_point_map, document.main_grid);
+        const std::optional<objects::ObjectId> highlighted_object =
+            objects::pick(document.object_layer, mouse_point_map);
+
+        // TODO: take camera rotation into account if it will be ever used
+        const Vector2 viewport_min = GetScreenToWorld2D({0.f, 0.f}, document.main_camera);
+        const Vector2 viewport_max = GetScreenToWorld2D({screen_width, screen_height}, document.main_camera);
+        const Rectangle viewport{.x = viewport_min.x,
+                                 .y = viewport_min.y,
+                                 .width = viewport_max.x - viewport_min.x,
+                                 .height = viewport_max.y - viewport_min.y};
 
         BeginDrawing();
 
         ClearBackground(RAYWHITE);
 
-        BeginMode2D(app_state.main_camera);
-        drawing::draw_main_area(app_state);
-        if (highlighted_map_tile)
+        BeginMode2D(document.main_camera);
+        drawing::draw_main_area(document, viewport);
+        drawing::draw_object_layer(app_state, viewport, visible_objects);
+        if (highlighted_object)
+        {
+            drawing::draw_highlighted_object(objects::get_object(document.object_layer, highlighted_object.value()));
+        }
+        else if (highlighted_map_tile)
         {
             drawing::draw_highlighted_tile(highlighted_map_tile.value());
         }
         EndMode2D();
 
-        drawing::draw_ui(layers, ui);
+        const auto ui_start = std::chrono::steady_clock::now();
+        if (immediate_ui)
+        {
+            drawing::draw_ui(layers, ui);
+        }
+        else
+        {
+            drawing::draw_ui(ui_display_list);
+        }
+        const std::chrono::duration<double, std::milli> ui_time = std::chrono::steady_clock::now() - ui_start;
 
         const int sc_x = screen_width * 0.025f;
         const int sc_y = screen_height * 0.125f;
@@ -171,6 +273,32 @@ int main(void)
         EndScissorMode();
 
         EndDrawing();
+
+        if (replay.has_value())
+        {
+            const std::chrono::duration<double, std::milli> frame_time = std::chrono::steady_clock::now() - frame_start;
+            replay_stats.frame_times_ms.push_back(frame_time.count());
+            replay_stats.ui_times_ms.push_back(ui_time.count());
+        }
+    }
+
+    // unsaved map makes te exit with 1, the same way as failed recording or replay
+    bool passed = autosave::flush(autosave_worker, app_state);
+    autosave::stop(autosave_worker);
+
+    if (options.mode == recording::Mode::RECORD)
+    {
+        passed = recording::save(recorded, options.path) and passed;
+    }
+    else if (replay.has_value())
+    {
+        replay_stats.cpu_time_s = recording::get_cpu_time_s() - cpu_time_start;
+        replay_stats.peak_rss_mb = recording::get_peak_rss_mb();
+        const recording::Thresholds thresholds{
+            .max_p99_frame_ms = config["replay"]["max_p99_frame_ms"].as<double>(),
+            .max_cpu_time_s = config["replay"]["max_cpu_time_s"].as<double>(),
+            .max_peak_rss_mb = config["replay"]["max_peak_rss_mb"].as<long>()};
+        passed = recording::report(replay_stats, thresholds) and passed;
     }
 
     for (const auto &tilemap : app_state.tilemaps)
@@ -178,5 +306,5 @@ int main(void)
         UnloadTexture(tilemap.texture);
     }
     CloseWindow();
-    return 0;
+    return passed ? 0 : 1;
 }
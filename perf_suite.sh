@@ -0,0 +1,41 @@
+#!/usr/bin/bash
+
+# Replays every recorded session (te --record <file>) from resources/recordings,
+# then the benchmark configs from resources/benchmarks with the recording each of them is made for.
+# Fails when any run exceeds thresholds from the replay section of config.yaml.
+# Run from the build directory, like te itself.
+
+SCRIPT_PATH="$(readlink -f "$0")"
+SCRIPT_DIR="$(dirname "${SCRIPT_PATH}")"
+ROOT_DIR="$(readlink -f ${SCRIPT_DIR})"
+RECORDINGS_DIR="${ROOT_DIR}/resources/recordings"
+BENCHMARKS_DIR="${ROOT_DIR}/resources/benchmarks"
+
+# benchmark config and recording replayed with it
+BENCHMARKS=(
+    "objects_500k.yaml pan_zoom.rec"
+    "ui_500_widgets.yaml tilesheet_browsing.rec"
+    "ui_500_widgets_immediate.yaml tilesheet_browsing.rec"
+    "autosave_16k.yaml painting.rec"
+    "autosave_16k_off.yaml painting.rec"
+)
+
+RECORDINGS="$(find "${RECORDINGS_DIR}" -name "*.rec" 2>/dev/null | sort)"
+if [ -z "${RECORDINGS}" ]; then
+    echo "No recordings found in ${RECORDINGS_DIR}"
+    exit 1
+fi
+
+FAILED=0
+for RECORDING in ${RECORDINGS}; do
+    echo "=== $(basename "${RECORDING}")"
+    ./te --replay "${RECORDING}" || FAILED=1
+done
+
+for BENCHMARK in "${BENCHMARKS[@]}"; do
+    read -r CONFIG RECORDING <<< "${BENCHMARK}"
+    echo "=== ${CONFIG} ${RECORDING}"
+    ./te --config "${BENCHMARKS_DIR}/${CONFIG}" --replay "${RECORDINGS_DIR}/${RECORDING}" || FAILED=1
+done
+
+exit ${FAILED}
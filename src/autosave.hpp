@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "engine_core.hpp"
+#include "map_file.hpp"
+#include "object_layer.hpp"
+
+namespace autosave
+{
+
+struct Settings
+{
+    // when disabled maps are saved only on exit
+    bool enabled{true};
+    double interval_s{};
+    unsigned max_dirty_chunks{};
+};
+
+struct ChunkSnapshot
+{
+    unsigned index{};
+    std::vector<objects::Slot> slots{};
+};
+
+// Copy of chunks changed since the previous snapshot, everything else is reused from worker's cache.
+// Full snapshot replaces the whole cache, it is taken when the map is opened and is not written.
+struct Snapshot
+{
+    std::string filename{};
+    Grid main_grid{};
+    unsigned chunk_count{};
+    bool full{};
+    bool write{true};
+    std::vector<ChunkSnapshot> chunks{};
+};
+
+// Main thread only takes snapshots, compressing and writing happens on the worker thread.
+// compressed_chunks is touched only by the worker, the rest is guarded by mutex.
+// pending holds filename once for every queued or running snapshot, failed holds maps whose last write failed.
+// Cache keeps chunks of a failed write, so the next save of that map writes them even when nothing is dirty.
+struct Worker
+{
+    std::mutex mutex{};
+    std::condition_variable_any condition{};
+    std::condition_variable_any idle{};
+    std::deque<Snapshot> queue{};
+    std::multiset<std::string> pending{};
+    std::set<std::string> failed{};
+    std::map<std::string, std::vector<std::vector<unsigned char>>> compressed_chunks{};
+    std::jthread thread{};
+};
+
+inline Snapshot take_snapshot(const Document &document, const bool full)
+{
+    const objects::ObjectLayer &layer = document.object_layer;
+    const std::size_t slot_count = layer.slots.size();
+    const auto chunk_count = static_cast<unsigned>((slot_count + objects::chunk_size - 1) / objects::chunk_size);
+    Snapshot snapshot{.filename = document.filename,
+                      .main_grid = document.main_grid,
+                      .chunk_count = chunk_count,
+                      .full = full,
+                      .write = not full,
+                      .chunks = {}};
+
+    for (unsigned chunk = 0; chunk < chunk_count; chunk++)
+    {
+        if (full or ((chunk < layer.dirty_chunks.size()) and layer.dirty_chunks[chunk]))
+        {
+            const std::size_t begin = chunk * objects::chunk_size;
+            const std::size_t end = std::min<std::size_t>(begin + objects::chunk_size, slot_count);
+            snapshot.chunks.push_back(
+                ChunkSnapshot{chunk, std::vector<objects::Slot>(layer.slots.data() + begin, layer.slots.data() + end)});
+        }
+    }
+    return snapshot;
+}
+
+// returns false when the map file could not be written
+inline bool save(Worker &worker, const Snapshot &snapshot)
+{
+    std::vector<std::vector<unsigned char>> &chunks = worker.compressed_chunks[snapshot.filename];
+    if (snapshot.full)
+    {
+        chunks.clear();
+    }
+    chunks.resize(std::max<std::size_t>(chunks.size(), snapshot.chunk_count));
+    for (const ChunkSnapshot &chunk : snapshot.chunks)
+    {
+        chunks[chunk.index] = map_file::compress_chunk(chunk.slots);
+    }
+    return not snapshot.write or map_file::write(snapshot.filename, snapshot.main_grid, chunks);
+}
+
+inline void run(std::stop_token stop_token, Worker &worker)
+{
+    // saving can wait, frames can't, this matters when there are fewer free cores than busy threads
+    setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), 10);
+    while (true)
+    {
+        std::unique_lock lock{worker.mutex};
+        // queue is drained before stopping, so saves requested on exit are not lost
+        worker.condition.wait(lock, stop_token, [&worker] { return not worker.queue.empty(); });
+        if (worker.queue.empty())
+        {
+            return;
+        }
+        const Snapshot snapshot = std::move(worker.queue.front());
+        worker.queue.pop_front();
+        lock.unlock();
+
+        const bool saved = save(worker, snapshot);
+
+        lock.lock();
+        worker.pending.erase(worker.pending.find(snapshot.filename));
+        if (saved)
+        {
+            worker.failed.erase(snapshot.filename);
+        }
+        else
+        {
+            printf("Autosave of %s failed, changes are kept for the next save\n", snapshot.filename.c_str());
+            worker.failed.insert(snapshot.filename);
+        }
+        if (worker.pending.empty())
+        {
+            worker.idle.notify_all();
+        }
+    }
+}
+
+inline void start(Worker &worker) { worker.thread = std::jthread(run, std::ref(worker)); }
+
+inline void stop(Worker &worker)
+{
+    worker.thread.request_stop();
+    if (worker.thread.joinable())
+    {
+        worker.thread.join();
+    }
+}
+
+inline void wait_idle(Worker &worker)
+{
+    std::unique_lock lock{worker.mutex};
+    worker.idle.wait(lock, [&worker] { return worker.pending.empty(); });
+}
+
+inline void enqueue(Worker &worker, Snapshot &&snapshot)
+{
+    {
+        const std::lock_guard lock{worker.mutex};
+        worker.pending.insert(snapshot.filename);
+        worker.queue.push_back(std::move(snapshot));
+    }
+    worker.condition.notify_one();
+}
+
+// Fills worker's cache with the whole map while it is being opened, so autosaves during editing copy only
+// chunks changed since then. Unsaved changes made before opening (none after loading) are kept dirty.
+inline void open(Worker &worker, const Document &document) { enqueue(worker, take_snapshot(document, true)); }
+
+inline void request_save(Worker &worker, Document &document)
+{
+    enqueue(worker, take_snapshot(document, false));
+    objects::clear_dirty(document.object_layer);
+}
+
+// saves started by update and due saves which waited for the previous save of the same map,
+// the split depends on how fast the worker is, not on the frame
+struct Activity
+{
+    unsigned requested{};
+    unsigned postponed{};
+};
+
+// called every frame, saves document when interval passed or too many chunks changed since the last save
+inline Activity update(Worker &worker, AppState &app_state, const Settings &settings, const double time_s)
+{
+    Activity activity{};
+    if (not settings.enabled)
+    {
+        return activity;
+    }
+    for (Document &document : app_state.documents)
+    {
+        bool pending = false;
+        bool failed = false;
+        {
+            const std::lock_guard lock{worker.mutex};
+            pending = worker.pending.contains(document.filename);
+            failed = worker.failed.contains(document.filename);
+        }
+
+        // failed save is retried after interval, so a full disk isn't written to every frame
+        const unsigned dirty_chunks = document.object_layer.dirty_chunk_count;
+        const bool interval_passed = (time_s - document.last_autosave_time_s) >= settings.interval_s;
+        if (((dirty_chunks == 0) and not failed) or
+            (not interval_passed and (dirty_chunks < settings.max_dirty_chunks)))
+        {
+            continue;
+        }
+        // previous save of this document is still running, dirty chunks will go with the next one
+        if (pending)
+        {
+            activity.postponed++;
+            continue;
+        }
+        request_save(worker, document);
+        document.last_autosave_time_s = time_s;
+        activity.requested++;
+    }
+    return activity;
+}
+
+// Saves every document with unsaved changes or failed last save and waits for it, used before exit.
+// Returns false when any of them could not be written.
+inline bool flush(Worker &worker, AppState &app_state)
+{
+    wait_idle(worker);
+    for (Document &document : app_state.documents)
+    {
+        bool failed = false;
+        {
+            const std::lock_guard lock{worker.mutex};
+            failed = worker.failed.contains(document.filename);
+        }
+        if ((document.object_layer.dirty_chunk_count != 0) or failed)
+        {
+            request_save(worker, document);
+        }
+    }
+    wait_idle(worker);
+
+    const std::lock_guard lock{worker.mutex};
+    return worker.failed.empty();
+}
+
+} // namespace autosave
@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "raylib.h"
+#include "yaml-cpp/yaml.h"
+#include "engine_core.hpp"
+#include "object_layer.hpp"
+
+// Synthetic content for performance measurements, enabled by the benchmark section of config
+// (see resources/benchmarks), normal configs don't have it.
+namespace benchmark
+{
+
+inline unsigned get_count(const YAML::Node &config, const std::string &key)
+{
+    const YAML::Node benchmark = config["benchmark"];
+    if (not benchmark.IsDefined() or not benchmark[key].IsDefined())
+    {
+        return 0;
+    }
+    return benchmark[key].as<unsigned>();
+}
+
+inline bool is_enabled(const YAML::Node &config, const std::string &key)
+{
+    const YAML::Node benchmark = config["benchmark"];
+    return benchmark.IsDefined() and benchmark[key].IsDefined() and benchmark[key].as<bool>();
+}
+
+// adds widgets of every interface item type to the interface section, in rows under the tile bank
+inline void add_widgets(YAML::Node &config, const unsigned count, const float screen_width, const float screen_height)
+{
+    const unsigned row_size = 25;
+    const float width = 0.024f;
+    const float height = 0.011f;
+    const float gap = 0.002f;
+    // load_interface scales triangle y by screen width
+    const float triangle_y_scale = screen_height / screen_width;
+    const std::array<const char *, 4> types{"box", "textbox", "triangle", "text"};
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const float x = 0.35f + (width + gap) * (i % row_size);
+        const float y = 0.75f + (height + gap) * (i / row_size);
+        const std::string type = types[i % types.size()];
+        std::array<char, 16> label{};
+        snprintf(label.data(), label.size(), "W%03u", i);
+
+        YAML::Node widget{};
+        widget["layer"] = 3;
+        widget["type"] = type;
+        if (type == "triangle")
+        {
+            widget["p1x"] = x + width / 2.f;
+            widget["p1y"] = y * triangle_y_scale;
+            widget["p2x"] = x;
+            widget["p2y"] = (y + height) * triangle_y_scale;
+            widget["p3x"] = x + width;
+            widget["p3y"] = (y + height) * triangle_y_scale;
+        }
+        else
+        {
+            widget["position_x"] = x;
+            widget["position_y"] = y;
+            widget["width"] = width;
+            widget["height"] = height;
+            widget["text"] = label.data();
+            widget["text_margin"] = 0.2f;
+            widget["font_size"] = 10;
+        }
+        widget["color"]["r"] = (i * 37) % 256;
+        widget["color"]["g"] = (i * 91) % 256;
+        widget["color"]["b"] = (i * 53) % 256;
+        widget["color"]["a"] = 255;
+        config["interface"]["benchmark_widget_" + std::to_string(i)] = widget;
+    }
+}
+
+// Fills every map with randomly placed and rotated tiles, same seed gives the same layer on every run.
+// They count as already saved content of the map, like objects loaded from a file.
+inline void populate_objects(AppState &app_state, const unsigned count)
+{
+    if ((count == 0) or app_state.tilemaps.empty())
+    {
+        return;
+    }
+
+    std::mt19937 generator{0};
+    const auto last_tilemap = static_cast<unsigned>(app_state.tilemaps.size() - 1);
+    std::uniform_int_distribution<unsigned> tilemap_distribution{0, last_tilemap};
+    std::uniform_real_distribution<float> rotation_distribution{0.f, 360.f};
+    const int tile_size = app_state.tile_size;
+    for (Document &document : app_state.documents)
+    {
+        const Grid &grid = document.main_grid;
+        const float scale = grid.square_size_px / tile_size;
+        std::uniform_real_distribution<float> x_distribution{0.f, 1.f * grid.x_square_count * grid.square_size_px};
+        std::uniform_real_distribution<float> y_distribution{0.f, 1.f * grid.y_square_count * grid.square_size_px};
+
+        std::vector<objects::Object> populated{};
+        populated.reserve(count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            const unsigned tilemap_index = tilemap_distribution(generator);
+            const Texture2D &texture = app_state.tilemaps[tilemap_index].texture;
+            std::uniform_int_distribution<int> column_distribution{0, texture.width / tile_size - 1};
+            std::uniform_int_distribution<int> row_distribution{0, texture.height / tile_size - 1};
+            const Rectangle source{.x = column_distribution(generator) * tile_size,
+                                   .y = row_distribution(generator) * tile_size,
+                                   .width = tile_size,
+                                   .height = tile_size};
+            populated.push_back(objects::Object{.tilemap_index = tilemap_index,
+                                                .source = source,
+                                                .position = {x_distribution(generator), y_distribution(generator)},
+                                                .size = {tile_size * scale, tile_size * scale},
+                                                .rotation = rotation_distribution(generator)});
+        }
+        objects::insert(document.object_layer, populated);
+        objects::clear_dirty(document.object_layer);
+    }
+}
+
+} // namespace benchmark
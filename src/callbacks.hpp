@@ -2,6 +2,7 @@
 #include <map>
 #include <array>
 #include "engine_core.hpp"
+#include "object_layer.hpp"
 #include "ui.hpp"
 #include "raylib.h"
 #include "raymath.h"
@@ -109,9 +110,9 @@ inline std::array<Vector2, 2> get_camera_boundaries(const Grid &grid)
     return {min, max};
 }
 
-inline void pan_camera(Camera2D &camera, const Vector2 &clamp_min, const Vector2 &clamp_max)
+inline void pan_camera(Camera2D &camera, const Inputs &inputs, const Vector2 &clamp_min, const Vector2 &clamp_max)
 {
-    const Vector2 delta = Vector2Scale(GetMouseDelta(), -1.0f / camera.zoom);
+    const Vector2 delta = Vector2Scale(inputs.mouse_delta, -1.0f / camera.zoom);
     camera.target = Vector2Clamp(Vector2Add(camera.target, delta), clamp_min, clamp_max);
 }
 
@@ -129,19 +130,66 @@ inline void main_area(const Inputs &inputs, std::map<std::string, UI::Item> &, A
 {
     if (is_hovered)
     {
+        Document &document = get_document(app_state);
         if ((inputs.right_mouse_button == MouseButtonState::DOWN) or
             (inputs.right_mouse_button == MouseButtonState::PRESSED))
         {
-            const auto [min, max] = get_camera_boundaries(app_state.main_grid);
-            pan_camera(app_state.main_camera, min, max);
+            const auto [min, max] = get_camera_boundaries(document.main_grid);
+            pan_camera(document.main_camera, inputs, min, max);
         }
         if (inputs.wheel != 0)
         {
-            zoom_camera(app_state.main_camera, inputs);
+            zoom_camera(document.main_camera, inputs);
+        }
+
+        const Vector2 mouse_point_map = GetScreenToWorld2D(inputs.mouse_point, document.main_camera);
+        const std::optional<objects::ObjectId> hovered_object = objects::pick(document.object_layer, mouse_point_map);
+        if (hovered_object.has_value())
+        {
+            if (inputs.delete_key_pressed)
+            {
+                objects::remove(document.object_layer, hovered_object.value());
+                return;
+            }
+            if (inputs.rotate_key_pressed)
+            {
+                // TODO: rotation step in yaml
+                objects::Object object = objects::get_object(document.object_layer, hovered_object.value());
+                object.rotation += 15.f;
+                objects::update(document.object_layer, hovered_object.value(), object);
+            }
+        }
+
+        if ((inputs.left_mouse_button == MouseButtonState::PRESSED) and app_state.selected_tile.has_value())
+        {
+            const Rectangle &source = app_state.selected_tile->source;
+            const float scale = document.main_grid.square_size_px / app_state.tile_size;
+            const objects::Object object{.tilemap_index = app_state.selected_tile->tilemap_index,
+                                         .source = source,
+                                         .position = mouse_point_map,
+                                         .size = {source.width * scale, source.height * scale},
+                                         .rotation = 0.f};
+            objects::insert(document.object_layer, object);
         }
     }
 }
 
+// TODO: move somewhere else
+inline std::optional<Rectangle> get_texture_source(const Vector2 &mouse_point_texture, const AppState &app_state)
+{
+    const Texture2D &texture = app_state.tilemaps[app_state.tilemap_index].texture;
+    const int square_size = app_state.texture_grid.square_size_px;
+    const int x = std::floor(mouse_point_texture.x / square_size) - app_state.texture_grid_margin;
+    const int y = std::floor(mouse_point_texture.y / square_size) - app_state.texture_grid_margin;
+    if ((x < 0) or (y < 0) or (x >= texture.width / app_state.tile_size) or (y >= texture.height / app_state.tile_size))
+    {
+        return std::nullopt;
+    }
+
+    const int tile_size = app_state.tile_size;
+    return Rectangle{.x = x * tile_size, .y = y * tile_size, .width = tile_size, .height = tile_size};
+}
+
 inline void texture_area(const Inputs &inputs, std::map<std::string, UI::Item> &, AppState &app_state,
                          const bool is_hovered)
 {
@@ -151,12 +199,21 @@ inline void texture_area(const Inputs &inputs, std::map<std::string, UI::Item> &
             (inputs.right_mouse_button == MouseButtonState::PRESSED))
         {
             const auto [min, max] = get_camera_boundaries(app_state.texture_grid);
-            pan_camera(app_state.texture_camera, min, max);
+            pan_camera(app_state.texture_camera, inputs, min, max);
         }
         if (inputs.wheel != 0)
         {
             zoom_camera(app_state.texture_camera, inputs);
         }
+        if ((inputs.left_mouse_button == MouseButtonState::PRESSED) and not app_state.tilemaps.empty())
+        {
+            const Vector2 mouse_point_texture = GetScreenToWorld2D(inputs.mouse_point, app_state.texture_camera);
+            const std::optional<Rectangle> source = get_texture_source(mouse_point_texture, app_state);
+            if (source.has_value())
+            {
+                app_state.selected_tile = TileSelection{app_state.tilemap_index, source.value()};
+            }
+        }
     }
 }
 
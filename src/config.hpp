@@ -1,12 +1,35 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
 #include "raylib.h"
 #include "yaml-cpp/yaml.h"
+#include "engine_core.hpp"
+#include "map_file.hpp"
+#include "object_layer.hpp"
 #include "ui.hpp"
 
 namespace config
 {
 
+// every overlay replaces whole top level sections of the base config, so it only has to contain what differs
+inline YAML::Node load_config(const std::string &base_path, const std::vector<std::string> &overlay_paths)
+{
+    YAML::Node config = YAML::LoadFile(base_path);
+    for (const std::string &overlay_path : overlay_paths)
+    {
+        for (const auto &section : YAML::LoadFile(overlay_path))
+        {
+            config[section.first.as<std::string>()] = section.second;
+        }
+    }
+    return config;
+}
+
 inline std::array<int, 2> get_screen_size(const YAML::Node &config)
 {
     if (config["screen"]["fullscreen"].as<bool>())
@@ -128,4 +151,74 @@ inline std::vector<Tilemap> load_textures(const YAML::Node &config)
     return tilemaps;
 }
 
+// cells grow on large maps, so the index of a 16k x 16k map has as many cells as the one of a small map
+inline int get_cell_size_tiles(const YAML::Node &config, const Grid &grid)
+{
+    const int cell_size_tiles = config["object_layer"]["cell_size_tiles"].as<int>();
+    const int max_cells_per_axis = config["object_layer"]["max_cells_per_axis"].as<int>();
+    const int square_count = std::max(grid.x_square_count, grid.y_square_count);
+    return std::max(cell_size_tiles, (square_count + max_cells_per_axis - 1) / max_cells_per_axis);
+}
+
+// first of <filename>.recovered, <filename>.recovered.1, ... which doesn't exist yet
+inline std::string get_recovery_filename(const std::string &filename)
+{
+    std::string recovery_filename = filename + ".recovered";
+    for (int i = 1; std::filesystem::exists(recovery_filename); i++)
+    {
+        recovery_filename = filename + ".recovered." + std::to_string(i);
+    }
+    return recovery_filename;
+}
+
+// maps are loaded from map_path when the file exists, otherwise an empty map of the configured size is created.
+// Existing file which can't be loaded is never overwritten, the empty map is saved under a recovery name instead.
+// Replay always starts from empty maps and autosaves them to te-replay in the system temporary directory,
+// so it is repeatable and doesn't touch user maps nor the source tree.
+inline std::vector<Document> load_documents(const YAML::Node &config, const std::size_t tilemap_count,
+                                            const bool replay)
+{
+    const int tile_size = config["tile_size_px"].as<int>();
+    const int square_size = tile_size * config["main_grid"]["initial_scale"].as<int>();
+    std::vector<Document> documents{};
+    documents.reserve(config["maps"].size());
+    for (const auto &map : config["maps"])
+    {
+        const std::string directory = replay ? (std::filesystem::temp_directory_path() / "te-replay").string()
+                                             : "../" + config["map_path"].as<std::string>();
+        const std::string filename = directory + "/" + map["filename"].as<std::string>();
+        const std::optional<map_file::LoadedMap> loaded =
+            replay ? std::nullopt : map_file::load(filename, tilemap_count);
+        const bool rejected = not replay and not loaded.has_value() and std::filesystem::exists(filename);
+        const Grid main_grid = loaded.has_value() ? loaded->main_grid
+                                                  : Grid{.x_square_count = map["count_x"].as<int>(),
+                                                         .y_square_count = map["count_y"].as<int>(),
+                                                         .square_size_px = square_size};
+
+        Document &document = documents.emplace_back();
+        document.filename = rejected ? get_recovery_filename(filename) : filename;
+        if (rejected)
+        {
+            printf("Cannot open map %s, it is left untouched and changes are saved to %s\n", filename.c_str(),
+                   document.filename.c_str());
+        }
+        document.main_grid = main_grid;
+        document.main_camera.zoom = 1.0f;
+        document.object_layer = objects::make_object_layer(
+            main_grid.square_size_px * main_grid.x_square_count, main_grid.square_size_px * main_grid.y_square_count,
+            main_grid.square_size_px * get_cell_size_tiles(config, main_grid));
+        if (loaded.has_value())
+        {
+            for (const map_file::SavedObject &saved : loaded->objects)
+            {
+                objects::insert(document.object_layer, saved.object);
+            }
+            objects::clear_dirty(document.object_layer);
+        }
+    }
+    assert(not documents.empty());
+
+    return documents;
+}
+
 } // namespace config
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+#include "raylib.h"
+#include "ui.hpp"
+
+namespace display_list
+{
+
+struct FilledRectangle
+{
+    Rectangle rectangle;
+    Color color;
+};
+
+struct FilledTriangle
+{
+    Vector2 p1;
+    Vector2 p2;
+    Vector2 p3;
+    Color color;
+};
+
+struct GlyphQuad
+{
+    Rectangle source;
+    Rectangle destination;
+};
+
+// text already laid out by the same rules as DrawText, so drawing it doesn't measure nor decode anything
+struct Glyphs
+{
+    std::vector<GlyphQuad> quads;
+    Color color;
+};
+
+using Command = std::variant<FilledRectangle, FilledTriangle, Glyphs>;
+
+// snapshot is the item state commands were built from, item is compared against it every frame
+struct Entry
+{
+    const UI::Item *item;
+    UI::Item snapshot;
+    std::vector<Command> commands;
+};
+
+struct DisplayList
+{
+    Font font{};
+    std::vector<Entry> entries{};
+};
+
+inline Glyphs layout_text(const Font &font, const UI::Text &text)
+{
+    // same values as raylib DrawText uses for default font
+    const int default_font_size = 10;
+    const int line_spacing = 2;
+    const int font_size = std::max(text.size, default_font_size);
+    const int spacing = font_size / default_font_size;
+    const float scale = static_cast<float>(font_size) / font.baseSize;
+    const float padding = font.glyphPadding;
+
+    Glyphs glyphs{.quads = {}, .color = text.color};
+    float offset_x = 0.f;
+    float offset_y = 0.f;
+    for (int i = 0; i < static_cast<int>(text.text.size());)
+    {
+        int codepoint_size = 0;
+        const int codepoint = GetCodepointNext(&text.text[static_cast<std::size_t>(i)], &codepoint_size);
+        const int index = GetGlyphIndex(font, codepoint);
+        i += codepoint_size;
+
+        if (codepoint == '\n')
+        {
+            offset_x = 0.f;
+            offset_y += font_size + line_spacing;
+            continue;
+        }
+
+        const Rectangle &rectangle = font.recs[index];
+        const GlyphInfo &glyph = font.glyphs[index];
+        if ((codepoint != ' ') and (codepoint != '\t'))
+        {
+            glyphs.quads.push_back(GlyphQuad{
+                .source = {.x = rectangle.x - padding,
+                           .y = rectangle.y - padding,
+                           .width = rectangle.width + 2.f * padding,
+                           .height = rectangle.height + 2.f * padding},
+                .destination = {.x = text.x + offset_x + (glyph.offsetX - padding) * scale,
+                                .y = text.y + offset_y + (glyph.offsetY - padding) * scale,
+                                .width = (rectangle.width + 2.f * padding) * scale,
+                                .height = (rectangle.height + 2.f * padding) * scale}});
+        }
+
+        const float advance = (glyph.advanceX == 0) ? rectangle.width : glyph.advanceX;
+        offset_x += advance * scale + spacing;
+    }
+    return glyphs;
+}
+
+// fully transparent items (like input areas) don't produce any commands
+inline void append_commands(const Font &, const UI::Box &box, std::vector<Command> &commands)
+{
+    if (box.color.a != 0)
+    {
+        commands.push_back(FilledRectangle{box.rectangle, box.color});
+    }
+}
+
+inline void append_commands(const Font &, const UI::Triangle &triangle, std::vector<Command> &commands)
+{
+    if (triangle.color.a != 0)
+    {
+        commands.push_back(FilledTriangle{triangle.p1, triangle.p2, triangle.p3, triangle.color});
+    }
+}
+
+inline void append_commands(const Font &font, const UI::Text &text, std::vector<Command> &commands)
+{
+    if (text.color.a != 0)
+    {
+        commands.push_back(layout_text(font, text));
+    }
+}
+
+inline void append_commands(const Font &font, const UI::Textbox &textbox, std::vector<Command> &commands)
+{
+    append_commands(font, textbox.box, commands);
+    append_commands(font, textbox.text, commands);
+}
+
+inline void rebuild(const Font &font, Entry &entry)
+{
+    entry.snapshot = *entry.item;
+    entry.commands.clear();
+    const auto visitor = [&font, &entry](const auto &i) { append_commands(font, i, entry.commands); };
+
+    entry.snapshot.visit(visitor);
+}
+
+// items are referenced by pointer, so ui map can't be rebuilt while the display list is in use
+inline DisplayList make_display_list(const std::vector<std::vector<std::string>> &layers,
+                                     std::map<std::string, UI::Item> &ui)
+{
+    DisplayList display_list{.font = GetFontDefault(), .entries = {}};
+    for (auto layer = layers.rbegin(); layer != layers.rend(); layer++)
+    {
+        for (const std::string &key : *layer)
+        {
+            Entry &entry = display_list.entries.emplace_back(Entry{&ui[key], ui[key], {}});
+            rebuild(display_list.font, entry);
+        }
+    }
+    return display_list;
+}
+
+// rebuilds commands only for items changed since the previous frame
+inline void update(DisplayList &display_list)
+{
+    for (Entry &entry : display_list.entries)
+    {
+        if (not UI::is_same(*entry.item, entry.snapshot))
+        {
+            rebuild(display_list.font, entry);
+        }
+    }
+}
+
+} // namespace display_list
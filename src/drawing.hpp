@@ -1,22 +1,34 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <variant>
 #include <map>
 #include "raylib.h"
+#include "display_list.hpp"
 #include "engine_core.hpp"
+#include "object_layer.hpp"
 #include "ui.hpp"
 #include "yaml-cpp/yaml.h"
 
 namespace drawing
 {
 
-inline void draw_main_area(const AppState &app_state)
+// only squares inside the viewport are drawn, so big maps don't cost more per frame than small ones
+inline void draw_main_area(const Document &document, const Rectangle &viewport)
 {
-    for (int i = 0; i < app_state.main_grid.x_square_count; i++)
+    const Grid &grid = document.main_grid;
+    const int square_size = grid.square_size_px;
+    const int min_i = std::clamp(static_cast<int>(std::floor(viewport.x / square_size)), 0, grid.x_square_count);
+    const int min_j = std::clamp(static_cast<int>(std::floor(viewport.y / square_size)), 0, grid.y_square_count);
+    const int max_i =
+        std::clamp(static_cast<int>(std::ceil((viewport.x + viewport.width) / square_size)), 0, grid.x_square_count);
+    const int max_j =
+        std::clamp(static_cast<int>(std::ceil((viewport.y + viewport.height) / square_size)), 0, grid.y_square_count);
+    for (int i = min_i; i < max_i; i++)
     {
-        for (int j = 0; j < app_state.main_grid.y_square_count; j++)
+        for (int j = min_j; j < max_j; j++)
         {
-            const int square_size = app_state.main_grid.square_size_px;
             DrawRectangleLines(i * square_size, j * square_size, square_size, square_size, BLACK);
         }
     }
@@ -48,6 +60,51 @@ inline void draw_highlighted_tile(const Rectangle &tile)
     DrawRectangleRec(tile, highlight);
 }
 
+// visible_objects is kept between frames, so culling neither allocates nor sorts while nothing changes
+inline void draw_object_layer(const AppState &app_state, const Rectangle &viewport,
+                              objects::VisibleSet &visible_objects)
+{
+    const objects::ObjectLayer &object_layer = get_document(app_state).object_layer;
+    objects::query(object_layer, viewport, visible_objects);
+    for (const objects::ObjectId id : visible_objects.ids)
+    {
+        const objects::Object &object = objects::get_object(object_layer, id);
+        const Rectangle destination{
+            .x = object.position.x, .y = object.position.y, .width = object.size.x, .height = object.size.y};
+        const Vector2 origin{object.size.x / 2.f, object.size.y / 2.f};
+        DrawTexturePro(app_state.tilemaps[object.tilemap_index].texture, object.source, destination, origin,
+                       object.rotation, WHITE);
+    }
+}
+
+inline void draw_highlighted_object(const objects::Object &object)
+{
+    Color highlight = BLUE;
+    highlight.a = 100;
+    const Rectangle destination{
+        .x = object.position.x, .y = object.position.y, .width = object.size.x, .height = object.size.y};
+    DrawRectanglePro(destination, {object.size.x / 2.f, object.size.y / 2.f}, object.rotation, highlight);
+}
+
+inline void draw(const Font &, const display_list::FilledRectangle &command)
+{
+    DrawRectangleRec(command.rectangle, command.color);
+}
+
+inline void draw(const Font &, const display_list::FilledTriangle &command)
+{
+    DrawTriangle(command.p1, command.p2, command.p3, command.color);
+}
+
+inline void draw(const Font &font, const display_list::Glyphs &command)
+{
+    for (const display_list::GlyphQuad &quad : command.quads)
+    {
+        DrawTexturePro(font.texture, quad.source, quad.destination, {0.f, 0.f}, 0.f, command.color);
+    }
+}
+
+// previous immediate drawing, measures and decodes text every frame, kept for comparing with benchmark.immediate_ui
 inline void draw_ui(const std::vector<std::vector<std::string>> &layers, std::map<std::string, UI::Item> &ui)
 {
     for (auto layer = layers.rbegin(); layer != layers.rend(); layer++)
@@ -55,7 +112,6 @@ inline void draw_ui(const std::vector<std::vector<std::string>> &layers, std::ma
         for (const std::string &key : *layer)
         {
             const auto &item = ui[key];
-            // TODO: add visitors with drawing to ui.hpp
             if (std::holds_alternative<UI::Box>(item))
             {
                 const auto &box = std::get<UI::Box>(item);
@@ -83,4 +139,19 @@ inline void draw_ui(const std::vector<std::vector<std::string>> &layers, std::ma
     }
 }
 
+inline void draw_ui(display_list::DisplayList &ui_display_list)
+{
+    display_list::update(ui_display_list);
+
+    const Font &font = ui_display_list.font;
+    const auto visitor = [&font](const auto &command) { draw(font, command); };
+    for (const display_list::Entry &entry : ui_display_list.entries)
+    {
+        for (const display_list::Command &command : entry.commands)
+        {
+            command.visit(visitor);
+        }
+    }
+}
+
 } // namespace drawing
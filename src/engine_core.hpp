@@ -1,8 +1,10 @@
 #pragma once
 #include <cassert>
+#include <optional>
 #include <string>
 #include <vector>
 #include "raylib.h"
+#include "object_layer.hpp"
 
 struct Tilemap
 {
@@ -18,12 +20,17 @@ enum class MouseButtonState
     RELEASED,
 };
 
+// everything callbacks read from raylib goes through here, so recorded sessions replay deterministically
 struct Inputs
 {
     Vector2 mouse_point{};
     MouseButtonState left_mouse_button{};
     MouseButtonState right_mouse_button{};
     float wheel{};
+    Vector2 mouse_delta{};
+    bool delete_key_pressed{};
+    bool rotate_key_pressed{};
+    bool next_document_key_pressed{};
 };
 
 struct Grid
@@ -33,18 +40,39 @@ struct Grid
     int square_size_px{};
 };
 
-struct AppState
+struct TileSelection
+{
+    unsigned tilemap_index{};
+    Rectangle source{};
+};
+
+// one open map, every map has its own camera and is autosaved separately
+struct Document
 {
+    std::string filename{};
     Grid main_grid{};
-    Grid texture_grid{};
     Camera2D main_camera{};
+    objects::ObjectLayer object_layer{};
+    double last_autosave_time_s{};
+};
+
+struct AppState
+{
+    std::vector<Document> documents{};
+    unsigned document_index{0};
+    Grid texture_grid{};
     Camera2D texture_camera{};
     std::vector<Tilemap> tilemaps{};
     unsigned tilemap_index{0};
     int tile_size{};
     int texture_grid_margin{};
+    std::optional<TileSelection> selected_tile{};
 };
 
+inline Document &get_document(AppState &app_state) { return app_state.documents[app_state.document_index]; }
+
+inline const Document &get_document(const AppState &app_state) { return app_state.documents[app_state.document_index]; }
+
 inline MouseButtonState get_mouse_button_state(const MouseButton button)
 {
     if (IsMouseButtonReleased(button))
@@ -70,5 +98,6 @@ inline MouseButtonState get_mouse_button_state(const MouseButton button)
 inline Inputs get_inputs()
 {
     return {GetMousePosition(), get_mouse_button_state(MOUSE_BUTTON_LEFT), get_mouse_button_state(MOUSE_BUTTON_RIGHT),
-            GetMouseWheelMove()};
+            GetMouseWheelMove(), GetMouseDelta(), IsKeyPressed(KEY_DELETE), IsKeyPressed(KEY_R),
+            IsKeyPressed(KEY_TAB)};
 }
@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "engine_core.hpp"
+#include "object_layer.hpp"
+
+namespace map_file
+{
+
+// File layout (native endianness):
+// magic, version, main grid (3 x int32), chunk count (uint32),
+// then for every chunk: compressed size (uint32) and DEFLATE compressed array of SavedObject
+inline constexpr char magic[] = "te-map";
+inline constexpr std::uint32_t version = 1;
+
+struct SavedObject
+{
+    objects::Object object;
+    std::uint64_t order;
+};
+
+struct LoadedMap
+{
+    Grid main_grid{};
+    std::vector<SavedObject> objects{};
+};
+
+inline std::vector<unsigned char> compress_chunk(const std::vector<objects::Slot> &slots)
+{
+    std::vector<SavedObject> saved{};
+    saved.reserve(slots.size());
+    for (const objects::Slot &slot : slots)
+    {
+        if (slot.alive)
+        {
+            saved.push_back(SavedObject{slot.object, slot.order});
+        }
+    }
+    if (saved.empty())
+    {
+        return {};
+    }
+
+    int compressed_size = 0;
+    unsigned char *compressed = CompressData(reinterpret_cast<const unsigned char *>(saved.data()),
+                                             static_cast<int>(saved.size() * sizeof(SavedObject)), &compressed_size);
+    std::vector<unsigned char> chunk(compressed, compressed + compressed_size);
+    MemFree(compressed);
+    return chunk;
+}
+
+template <typename T>
+void write_value(std::ofstream &file, const T &value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::ifstream &file, T &value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+// flushes file or directory contents from the page cache to the disk
+inline bool sync_to_disk(const std::filesystem::path &path)
+{
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    const bool synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+}
+
+// Map is written to temporary file, synced and renamed over the old one, then the directory is synced.
+// So crash or power loss during save leaves either the previous or the new map, never a half written one.
+inline bool write(const std::string &filename, const Grid &main_grid,
+                  const std::vector<std::vector<unsigned char>> &chunks)
+{
+    const std::filesystem::path path{filename};
+    const std::filesystem::path temporary_path{filename + ".tmp"};
+    std::error_code error{};
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (not file)
+        {
+            printf("Cannot open map file: %s\n", temporary_path.c_str());
+            return false;
+        }
+        file.write(magic, sizeof(magic));
+        write_value(file, version);
+        write_value(file, main_grid);
+        write_value(file, static_cast<std::uint32_t>(chunks.size()));
+        for (const std::vector<unsigned char> &chunk : chunks)
+        {
+            write_value(file, static_cast<std::uint32_t>(chunk.size()));
+            file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        }
+        if (not file.flush())
+        {
+            printf("Cannot write map file: %s\n", temporary_path.c_str());
+            return false;
+        }
+    }
+    if (not sync_to_disk(temporary_path))
+    {
+        printf("Cannot sync map file: %s\n", temporary_path.c_str());
+        return false;
+    }
+
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        printf("Cannot rename %s: %s\n", temporary_path.c_str(), error.message().c_str());
+        return false;
+    }
+    // rename itself is durable only after the directory entry reaches the disk
+    const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : ".";
+    if (not sync_to_disk(directory))
+    {
+        printf("Cannot sync directory: %s\n", directory.c_str());
+        return false;
+    }
+    return true;
+}
+
+// larger maps are rejected when loading, so a corrupted header can't request a giant allocation
+inline constexpr int max_square_count = 65536;
+inline constexpr int max_square_size_px = 1024;
+
+inline bool is_valid(const Grid &grid)
+{
+    return (grid.x_square_count > 0) and (grid.x_square_count <= max_square_count) and (grid.y_square_count > 0) and
+           (grid.y_square_count <= max_square_count) and (grid.square_size_px > 0) and
+           (grid.square_size_px <= max_square_size_px);
+}
+
+inline bool is_valid(const SavedObject &saved, const std::size_t tilemap_count)
+{
+    const objects::Object &object = saved.object;
+    const float values[] = {object.source.x,   object.source.y,   object.source.width, object.source.height,
+                            object.position.x, object.position.y, object.size.x,       object.size.y,
+                            object.rotation};
+    return (object.tilemap_index < tilemap_count) and (object.size.x >= 0.f) and (object.size.y >= 0.f) and
+           std::all_of(std::begin(values), std::end(values), [](const float value) { return std::isfinite(value); });
+}
+
+// objects referencing tilemaps which are not loaded make the whole file invalid
+inline std::optional<LoadedMap> load(const std::string &filename, const std::size_t tilemap_count)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (not file)
+    {
+        return std::nullopt;
+    }
+
+    char file_magic[sizeof(magic)]{};
+    std::uint32_t file_version{};
+    std::uint32_t chunk_count{};
+    LoadedMap map{};
+    if (not file.read(file_magic, sizeof(file_magic)) or (std::memcmp(file_magic, magic, sizeof(magic)) != 0) or
+        not read_value(file, file_version) or (file_version != version) or not read_value(file, map.main_grid) or
+        not read_value(file, chunk_count) or not is_valid(map.main_grid))
+    {
+        printf("Not a valid map file: %s\n", filename.c_str());
+        return std::nullopt;
+    }
+
+    for (std::uint32_t i = 0; i < chunk_count; i++)
+    {
+        std::uint32_t compressed_size{};
+        if (not read_value(file, compressed_size))
+        {
+            printf("Truncated map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+        if (compressed_size == 0)
+        {
+            continue;
+        }
+
+        // size is checked against the rest of the file before allocating
+        const std::streamoff position = file.tellg();
+        file.seekg(0, std::ios::end);
+        const std::streamoff remaining = file.tellg() - position;
+        file.seekg(position);
+        if (static_cast<std::streamoff>(compressed_size) > remaining)
+        {
+            printf("Truncated map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+
+        std::vector<unsigned char> compressed(compressed_size);
+        if (not file.read(reinterpret_cast<char *>(compressed.data()), compressed_size))
+        {
+            printf("Truncated map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+        int size = 0;
+        unsigned char *data = DecompressData(compressed.data(), static_cast<int>(compressed_size), &size);
+        if (data == nullptr)
+        {
+            printf("Corrupted map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+        // chunk holds whole objects and never more than objects::chunk_size of them
+        const std::size_t count = static_cast<std::size_t>(size) / sizeof(SavedObject);
+        if (((static_cast<std::size_t>(size) % sizeof(SavedObject)) != 0) or (count > objects::chunk_size))
+        {
+            MemFree(data);
+            printf("Not a valid map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+        const std::size_t offset = map.objects.size();
+        map.objects.resize(offset + count);
+        std::memcpy(map.objects.data() + offset, data, count * sizeof(SavedObject));
+        MemFree(data);
+        if (not std::all_of(map.objects.begin() + static_cast<std::ptrdiff_t>(offset), map.objects.end(),
+                            [tilemap_count](const SavedObject &saved) { return is_valid(saved, tilemap_count); }))
+        {
+            printf("Not a valid map file: %s\n", filename.c_str());
+            return std::nullopt;
+        }
+    }
+
+    // restores drawing order, object ids are not preserved
+    std::sort(map.objects.begin(), map.objects.end(),
+              [](const SavedObject &a, const SavedObject &b) { return a.order < b.order; });
+    return map;
+}
+
+} // namespace map_file
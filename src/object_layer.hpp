@@ -0,0 +1,355 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "raylib.h"
+
+namespace objects
+{
+
+using ObjectId = unsigned;
+
+// slots are split into chunks of this size for saving, only chunks changed since last save are written again
+inline constexpr unsigned chunk_size = 4096;
+
+// Freely positioned sprite, position is the center of the sprite and rotation is in degrees (like in raylib)
+struct Object
+{
+    unsigned tilemap_index{};
+    Rectangle source{};
+    Vector2 position{};
+    Vector2 size{};
+    float rotation{};
+};
+
+struct CellRange
+{
+    int min_x{};
+    int min_y{};
+    int max_x{};
+    int max_y{};
+};
+
+struct Slot
+{
+    Object object{};
+    Rectangle bounds{};
+    CellRange cells{};
+    std::uint64_t order{};
+    bool alive{false};
+};
+
+// Objects are kept in slots (ids stay valid until removed) and indexed in a uniform grid of buckets.
+// Object which overlaps several cells is stored in each of them, so picking and culling only visit
+// the cells under the point or the viewport instead of the whole layer.
+struct ObjectLayer
+{
+    int x_cell_count{};
+    int y_cell_count{};
+    int cell_size_px{};
+    std::vector<Slot> slots{};
+    std::vector<ObjectId> free_slots{};
+    std::vector<std::vector<ObjectId>> cells{};
+    std::uint64_t next_order{0};
+    unsigned count{0};
+    // bumped by every insert, update and remove
+    std::uint64_t revision{0};
+    std::vector<bool> dirty_chunks{};
+    unsigned dirty_chunk_count{0};
+};
+
+// Culling result. Candidates (objects from cells under the viewport, in drawing order) are sorted only when
+// the viewport moves to other cells or the layer changes, every frame they are just filtered into ids.
+struct VisibleSet
+{
+    bool valid{false};
+    CellRange range{};
+    std::uint64_t revision{};
+    std::vector<ObjectId> candidates{};
+    std::vector<ObjectId> ids{};
+};
+
+inline ObjectLayer make_object_layer(const float width, const float height, const int cell_size_px)
+{
+    assert(cell_size_px > 0);
+    ObjectLayer layer{};
+    layer.x_cell_count = std::max(1, static_cast<int>(std::ceil(width / cell_size_px)));
+    layer.y_cell_count = std::max(1, static_cast<int>(std::ceil(height / cell_size_px)));
+    layer.cell_size_px = cell_size_px;
+    layer.cells.resize(static_cast<std::size_t>(layer.x_cell_count * layer.y_cell_count));
+    return layer;
+}
+
+// axis aligned bounding box of the rotated sprite
+inline Rectangle get_bounds(const Object &object)
+{
+    const float radians = object.rotation * DEG2RAD;
+    const float cos = std::fabs(std::cos(radians));
+    const float sin = std::fabs(std::sin(radians));
+    const float half_width = (cos * object.size.x + sin * object.size.y) / 2.f;
+    const float half_height = (sin * object.size.x + cos * object.size.y) / 2.f;
+    return {.x = object.position.x - half_width,
+            .y = object.position.y - half_height,
+            .width = 2.f * half_width,
+            .height = 2.f * half_height};
+}
+
+inline bool contains_point(const Object &object, const Vector2 &point)
+{
+    // move point to sprite local space, so rotated sprite can be tested as rectangle
+    const float radians = -object.rotation * DEG2RAD;
+    const float dx = point.x - object.position.x;
+    const float dy = point.y - object.position.y;
+    const float local_x = dx * std::cos(radians) - dy * std::sin(radians);
+    const float local_y = dx * std::sin(radians) + dy * std::cos(radians);
+    return (std::fabs(local_x) <= object.size.x / 2.f) and (std::fabs(local_y) <= object.size.y / 2.f);
+}
+
+// objects outside of the layer are stored in border cells, queries are clamped the same way
+inline int get_cell_coordinate(const float position, const int cell_size, const int cell_count)
+{
+    const int cell = static_cast<int>(std::floor(position / cell_size));
+    return std::clamp(cell, 0, cell_count - 1);
+}
+
+inline CellRange get_cell_range(const ObjectLayer &layer, const Rectangle &area)
+{
+    return {.min_x = get_cell_coordinate(area.x, layer.cell_size_px, layer.x_cell_count),
+            .min_y = get_cell_coordinate(area.y, layer.cell_size_px, layer.y_cell_count),
+            .max_x = get_cell_coordinate(area.x + area.width, layer.cell_size_px, layer.x_cell_count),
+            .max_y = get_cell_coordinate(area.y + area.height, layer.cell_size_px, layer.y_cell_count)};
+}
+
+inline std::vector<ObjectId> &get_cell(ObjectLayer &layer, const int x, const int y)
+{
+    return layer.cells[static_cast<std::size_t>(y * layer.x_cell_count + x)];
+}
+
+inline const std::vector<ObjectId> &get_cell(const ObjectLayer &layer, const int x, const int y)
+{
+    return layer.cells[static_cast<std::size_t>(y * layer.x_cell_count + x)];
+}
+
+inline void link(ObjectLayer &layer, const ObjectId id, const CellRange &range)
+{
+    for (int y = range.min_y; y <= range.max_y; y++)
+    {
+        for (int x = range.min_x; x <= range.max_x; x++)
+        {
+            get_cell(layer, x, y).push_back(id);
+        }
+    }
+}
+
+inline void unlink(ObjectLayer &layer, const ObjectId id, const CellRange &range)
+{
+    for (int y = range.min_y; y <= range.max_y; y++)
+    {
+        for (int x = range.min_x; x <= range.max_x; x++)
+        {
+            std::vector<ObjectId> &cell = get_cell(layer, x, y);
+            const auto it = std::find(cell.begin(), cell.end(), id);
+            assert(it != cell.end());
+            *it = cell.back();
+            cell.pop_back();
+        }
+    }
+}
+
+inline void mark_dirty(ObjectLayer &layer, const ObjectId id)
+{
+    const unsigned chunk = id / chunk_size;
+    if (chunk >= layer.dirty_chunks.size())
+    {
+        layer.dirty_chunks.resize(chunk + 1, false);
+    }
+    if (not layer.dirty_chunks[chunk])
+    {
+        layer.dirty_chunks[chunk] = true;
+        layer.dirty_chunk_count++;
+    }
+}
+
+inline void clear_dirty(ObjectLayer &layer)
+{
+    std::fill(layer.dirty_chunks.begin(), layer.dirty_chunks.end(), false);
+    layer.dirty_chunk_count = 0;
+}
+
+inline bool is_alive(const ObjectLayer &layer, const ObjectId id)
+{
+    return (id < layer.slots.size()) and layer.slots[id].alive;
+}
+
+inline const Object &get_object(const ObjectLayer &layer, const ObjectId id)
+{
+    assert(is_alive(layer, id));
+    return layer.slots[id].object;
+}
+
+inline ObjectId insert(ObjectLayer &layer, const Object &object)
+{
+    ObjectId id{};
+    if (layer.free_slots.empty())
+    {
+        id = static_cast<ObjectId>(layer.slots.size());
+        layer.slots.emplace_back();
+    }
+    else
+    {
+        id = layer.free_slots.back();
+        layer.free_slots.pop_back();
+    }
+
+    Slot &slot = layer.slots[id];
+    slot.object = object;
+    slot.bounds = get_bounds(object);
+    slot.cells = get_cell_range(layer, slot.bounds);
+    slot.order = layer.next_order++;
+    slot.alive = true;
+    link(layer, id, slot.cells);
+    mark_dirty(layer, id);
+    layer.revision++;
+    layer.count++;
+    return id;
+}
+
+inline std::vector<ObjectId> insert(ObjectLayer &layer, const std::vector<Object> &objects)
+{
+    layer.slots.reserve(layer.slots.size() + objects.size());
+    std::vector<ObjectId> ids{};
+    ids.reserve(objects.size());
+    for (const Object &object : objects)
+    {
+        ids.push_back(insert(layer, object));
+    }
+    return ids;
+}
+
+// updates position, size or rotation, cells are touched only when object crosses cell boundary
+inline void update(ObjectLayer &layer, const ObjectId id, const Object &object)
+{
+    assert(is_alive(layer, id));
+    Slot &slot = layer.slots[id];
+    slot.object = object;
+    slot.bounds = get_bounds(object);
+    const CellRange cells = get_cell_range(layer, slot.bounds);
+    if ((cells.min_x != slot.cells.min_x) or (cells.min_y != slot.cells.min_y) or
+        (cells.max_x != slot.cells.max_x) or (cells.max_y != slot.cells.max_y))
+    {
+        unlink(layer, id, slot.cells);
+        link(layer, id, cells);
+        slot.cells = cells;
+    }
+    mark_dirty(layer, id);
+    layer.revision++;
+}
+
+inline void move(ObjectLayer &layer, const ObjectId id, const Vector2 &position)
+{
+    Object object = get_object(layer, id);
+    object.position = position;
+    update(layer, id, object);
+}
+
+inline void move(ObjectLayer &layer, const std::vector<ObjectId> &ids, const Vector2 &delta)
+{
+    for (const ObjectId id : ids)
+    {
+        const Vector2 &position = get_object(layer, id).position;
+        move(layer, id, {position.x + delta.x, position.y + delta.y});
+    }
+}
+
+inline void remove(ObjectLayer &layer, const ObjectId id)
+{
+    assert(is_alive(layer, id));
+    Slot &slot = layer.slots[id];
+    unlink(layer, id, slot.cells);
+    slot.alive = false;
+    layer.free_slots.push_back(id);
+    mark_dirty(layer, id);
+    layer.revision++;
+    layer.count--;
+}
+
+inline void remove(ObjectLayer &layer, const std::vector<ObjectId> &ids)
+{
+    for (const ObjectId id : ids)
+    {
+        remove(layer, id);
+    }
+}
+
+inline bool is_same(const CellRange &a, const CellRange &b)
+{
+    return (a.min_x == b.min_x) and (a.min_y == b.min_y) and (a.max_x == b.max_x) and (a.max_y == b.max_y);
+}
+
+// fills visible.ids with objects overlapping the area, in drawing order
+inline void query(const ObjectLayer &layer, const Rectangle &area, VisibleSet &visible)
+{
+    const CellRange range = get_cell_range(layer, area);
+    if (not visible.valid or not is_same(range, visible.range) or (visible.revision != layer.revision))
+    {
+        visible.candidates.clear();
+        for (int y = range.min_y; y <= range.max_y; y++)
+        {
+            for (int x = range.min_x; x <= range.max_x; x++)
+            {
+                for (const ObjectId id : get_cell(layer, x, y))
+                {
+                    const Slot &slot = layer.slots[id];
+                    // object spanning several cells is reported only from the first one visited
+                    const bool first_x = x == std::max(range.min_x, slot.cells.min_x);
+                    const bool first_y = y == std::max(range.min_y, slot.cells.min_y);
+                    if (first_x and first_y)
+                    {
+                        visible.candidates.push_back(id);
+                    }
+                }
+            }
+        }
+        std::sort(visible.candidates.begin(), visible.candidates.end(),
+                  [&layer](const ObjectId a, const ObjectId b) { return layer.slots[a].order < layer.slots[b].order; });
+        visible.valid = true;
+        visible.range = range;
+        visible.revision = layer.revision;
+    }
+
+    visible.ids.clear();
+    for (const ObjectId id : visible.candidates)
+    {
+        if (CheckCollisionRecs(layer.slots[id].bounds, area))
+        {
+            visible.ids.push_back(id);
+        }
+    }
+}
+
+// returns topmost (last drawn) object under the point
+inline std::optional<ObjectId> pick(const ObjectLayer &layer, const Vector2 &point)
+{
+    const int x = get_cell_coordinate(point.x, layer.cell_size_px, layer.x_cell_count);
+    const int y = get_cell_coordinate(point.y, layer.cell_size_px, layer.y_cell_count);
+
+    std::optional<ObjectId> picked{std::nullopt};
+    for (const ObjectId id : get_cell(layer, x, y))
+    {
+        const Slot &slot = layer.slots[id];
+        if (picked.has_value() and (layer.slots[picked.value()].order > slot.order))
+        {
+            continue;
+        }
+        if (CheckCollisionPointRec(point, slot.bounds) and contains_point(slot.object, point))
+        {
+            picked = id;
+        }
+    }
+    return picked;
+}
+
+} // namespace objects
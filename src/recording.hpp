@@ -0,0 +1,311 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+#include "engine_core.hpp"
+
+namespace recording
+{
+
+enum class Mode
+{
+    INTERACTIVE,
+    RECORD,
+    REPLAY,
+};
+
+struct Options
+{
+    Mode mode{Mode::INTERACTIVE};
+    std::string path{};
+    // layered over resources/config.yaml in the given order
+    std::vector<std::string> config_overlays{};
+};
+
+// UI layout depends on screen size, so replay has to use the one from recording
+struct Recording
+{
+    int screen_width{};
+    int screen_height{};
+    std::vector<Inputs> frames{};
+};
+
+struct Thresholds
+{
+    double max_p99_frame_ms{};
+    double max_cpu_time_s{};
+    long max_peak_rss_mb{};
+};
+
+struct ReplayStats
+{
+    std::vector<double> frame_times_ms{};
+    // part of frame time spent in drawing::draw_ui
+    std::vector<double> ui_times_ms{};
+    double cpu_time_s{};
+    long peak_rss_mb{};
+    unsigned autosave_count{};
+    // frames on which a due autosave waited for the previous save of the same map
+    unsigned autosave_postponed_count{};
+};
+
+inline constexpr const char *header = "te-recording";
+inline constexpr int version = 3;
+// versions 1 and 2 stored frames as fixed columns, in this order, version 2 added next_document
+inline constexpr std::array<const char *, 10> legacy_columns{"x",  "y",  "left",   "right",  "wheel",
+                                                             "dx", "dy", "delete", "rotate", "next_document"};
+
+// returns nullopt for unknown argument or missing path, so a typo fails instead of starting the editor
+inline std::optional<Options> parse_arguments(const int argc, char **argv)
+{
+    Options options{};
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const bool takes_path = (argument == "--record") or (argument == "--replay") or (argument == "--config");
+        if (takes_path and (i + 1 >= argc))
+        {
+            printf("Missing path after %s\n", argument.c_str());
+            return std::nullopt;
+        }
+        else if ((argument == "--record") or (argument == "--replay"))
+        {
+            options.mode = (argument == "--record") ? Mode::RECORD : Mode::REPLAY;
+            options.path = argv[++i];
+        }
+        else if (argument == "--config")
+        {
+            options.config_overlays.push_back(argv[++i]);
+        }
+        else
+        {
+            printf("Unknown argument: %s\n", argument.c_str());
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+// Returns false for unknown key or value which doesn't fit it: coordinates are finite numbers,
+// buttons are MouseButtonState values 0 to 3 and keys are 0 or 1.
+inline bool set_field(Inputs &inputs, const std::string &key, const std::string &value)
+{
+    char *end = nullptr;
+    const float number = std::strtof(value.c_str(), &end);
+    if (value.empty() or (*end != '\0') or not std::isfinite(number))
+    {
+        return false;
+    }
+    const auto is_integer = [number](const float min, const float max)
+    { return (number == std::trunc(number)) and (number >= min) and (number <= max); };
+    const bool is_button = is_integer(0.f, static_cast<float>(MouseButtonState::RELEASED));
+    const bool is_key = is_integer(0.f, 1.f);
+
+    if (key == "x")
+    {
+        inputs.mouse_point.x = number;
+    }
+    else if (key == "y")
+    {
+        inputs.mouse_point.y = number;
+    }
+    else if ((key == "left") and is_button)
+    {
+        inputs.left_mouse_button = static_cast<MouseButtonState>(number);
+    }
+    else if ((key == "right") and is_button)
+    {
+        inputs.right_mouse_button = static_cast<MouseButtonState>(number);
+    }
+    else if (key == "wheel")
+    {
+        inputs.wheel = number;
+    }
+    else if (key == "dx")
+    {
+        inputs.mouse_delta.x = number;
+    }
+    else if (key == "dy")
+    {
+        inputs.mouse_delta.y = number;
+    }
+    else if ((key == "delete") and is_key)
+    {
+        inputs.delete_key_pressed = number != 0.f;
+    }
+    else if ((key == "rotate") and is_key)
+    {
+        inputs.rotate_key_pressed = number != 0.f;
+    }
+    else if ((key == "next_document") and is_key)
+    {
+        inputs.next_document_key_pressed = number != 0.f;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// One frame per line as space separated key=value pairs. Only fields which differ from default Inputs
+// are written, so a new key needs one line here and one in set_field and older recordings stay valid.
+inline bool save(const Recording &recording, const std::string &path)
+{
+    std::ofstream file(path);
+    if (not file)
+    {
+        printf("Cannot open recording file: %s\n", path.c_str());
+        return false;
+    }
+
+    file << header << ' ' << version << ' ' << recording.screen_width << ' ' << recording.screen_height << '\n';
+    for (const Inputs &inputs : recording.frames)
+    {
+        const char *separator = "";
+        const auto write_field = [&file, &separator](const char *key, const float value)
+        {
+            if (value != 0.f)
+            {
+                // shortest text which reads back as the same float, otherwise replay drifts from recorded session
+                std::array<char, 32> text{};
+                const char *text_end = std::to_chars(text.data(), text.data() + text.size(), value).ptr;
+                file << separator << key << '=' << std::string_view(text.data(), text_end);
+                separator = " ";
+            }
+        };
+        write_field("x", inputs.mouse_point.x);
+        write_field("y", inputs.mouse_point.y);
+        write_field("left", static_cast<float>(inputs.left_mouse_button));
+        write_field("right", static_cast<float>(inputs.right_mouse_button));
+        write_field("wheel", inputs.wheel);
+        write_field("dx", inputs.mouse_delta.x);
+        write_field("dy", inputs.mouse_delta.y);
+        write_field("delete", inputs.delete_key_pressed);
+        write_field("rotate", inputs.rotate_key_pressed);
+        write_field("next_document", inputs.next_document_key_pressed);
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+inline std::optional<Recording> load(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string file_header{};
+    int file_version{};
+    Recording recording{};
+    if (not(file >> file_header >> file_version >> recording.screen_width >> recording.screen_height) or
+        (file_header != header) or (file_version < 1) or (file_version > version))
+    {
+        printf("Not a valid recording: %s\n", path.c_str());
+        return std::nullopt;
+    }
+    // rest of the header line
+    std::string line{};
+    std::getline(file, line);
+
+    const std::size_t legacy_column_count = (file_version == 1) ? 9 : legacy_columns.size();
+    while (std::getline(file, line))
+    {
+        Inputs inputs{};
+        std::istringstream tokens(line);
+        std::string token{};
+        for (std::size_t column = 0; tokens >> token; column++)
+        {
+            std::string key{};
+            std::string value{};
+            if (file_version < 3)
+            {
+                key = (column < legacy_column_count) ? legacy_columns[column] : "";
+                value = token;
+            }
+            else if (const std::size_t equals = token.find('='); equals != std::string::npos)
+            {
+                key = token.substr(0, equals);
+                value = token.substr(equals + 1);
+            }
+
+            if (not set_field(inputs, key, value))
+            {
+                printf("Not a valid recording: %s, frame %zu: %s\n", path.c_str(), recording.frames.size(),
+                       token.c_str());
+                return std::nullopt;
+            }
+        }
+        recording.frames.push_back(inputs);
+    }
+    return recording;
+}
+
+inline double get_cpu_time_s() { return static_cast<double>(std::clock()) / CLOCKS_PER_SEC; }
+
+inline long get_peak_rss_mb()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is in kilobytes on linux
+    return usage.ru_maxrss / 1024;
+}
+
+inline double get_percentile(const std::vector<double> &sorted, const double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0.;
+    }
+    // nearest rank, so p99 of a short replay is not hidden by rounding down
+    const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100. * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+// prints frame time distribution and resources usage, returns false when any threshold is exceeded
+inline bool report(const ReplayStats &stats, const Thresholds &thresholds)
+{
+    std::vector<double> sorted = stats.frame_times_ms;
+    std::sort(sorted.begin(), sorted.end());
+    const double p99 = get_percentile(sorted, 99.);
+
+    printf("frames: %zu\n", sorted.size());
+    printf("frame time [ms] min: %.3f p50: %.3f p90: %.3f p99: %.3f max: %.3f\n", get_percentile(sorted, 0.),
+           get_percentile(sorted, 50.), get_percentile(sorted, 90.), p99, get_percentile(sorted, 100.));
+    std::vector<double> ui_sorted = stats.ui_times_ms;
+    std::sort(ui_sorted.begin(), ui_sorted.end());
+    printf("ui draw time [ms] p50: %.3f p99: %.3f max: %.3f\n", get_percentile(ui_sorted, 50.),
+           get_percentile(ui_sorted, 99.), get_percentile(ui_sorted, 100.));
+    printf("autosaves: %u started, %u frames with a due save waiting for the previous one\n", stats.autosave_count,
+           stats.autosave_postponed_count);
+    printf("cpu time [s]: %.3f\n", stats.cpu_time_s);
+    printf("peak rss [MB]: %ld\n", stats.peak_rss_mb);
+
+    bool passed = true;
+    if (p99 > thresholds.max_p99_frame_ms)
+    {
+        printf("FAIL: p99 frame time %.3f ms > %.3f ms\n", p99, thresholds.max_p99_frame_ms);
+        passed = false;
+    }
+    if (stats.cpu_time_s > thresholds.max_cpu_time_s)
+    {
+        printf("FAIL: cpu time %.3f s > %.3f s\n", stats.cpu_time_s, thresholds.max_cpu_time_s);
+        passed = false;
+    }
+    if (stats.peak_rss_mb > thresholds.max_peak_rss_mb)
+    {
+        printf("FAIL: peak rss %ld MB > %ld MB\n", stats.peak_rss_mb, thresholds.max_peak_rss_mb);
+        passed = false;
+    }
+    return passed;
+}
+
+} // namespace recording
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <type_traits>
 #include <variant>
 #include "engine_core.hpp"
 #include "raylib.h"
@@ -38,6 +39,46 @@ struct Textbox
 
 using Item = std::variant<Box, Triangle, Text, Textbox>;
 
+inline bool is_same(const Color &a, const Color &b)
+{
+    return (a.r == b.r) and (a.g == b.g) and (a.b == b.b) and (a.a == b.a);
+}
+
+inline bool is_same(const Vector2 &a, const Vector2 &b) { return (a.x == b.x) and (a.y == b.y); }
+
+inline bool is_same(const Rectangle &a, const Rectangle &b)
+{
+    return (a.x == b.x) and (a.y == b.y) and (a.width == b.width) and (a.height == b.height);
+}
+
+inline bool is_same(const Box &a, const Box &b)
+{
+    return is_same(a.rectangle, b.rectangle) and is_same(a.color, b.color);
+}
+
+inline bool is_same(const Triangle &a, const Triangle &b)
+{
+    return is_same(a.p1, b.p1) and is_same(a.p2, b.p2) and is_same(a.p3, b.p3) and is_same(a.color, b.color);
+}
+
+inline bool is_same(const Text &a, const Text &b)
+{
+    return (a.x == b.x) and (a.y == b.y) and (a.size == b.size) and (a.text == b.text) and is_same(a.color, b.color);
+}
+
+inline bool is_same(const Textbox &a, const Textbox &b) { return is_same(a.box, b.box) and is_same(a.text, b.text); }
+
+inline bool is_same(const Item &a, const Item &b)
+{
+    if (a.index() != b.index())
+    {
+        return false;
+    }
+    const auto visitor = [&b](const auto &i) { return is_same(i, std::get<std::decay_t<decltype(i)>>(b)); };
+
+    return a.visit(visitor);
+}
+
 inline bool is_hovered(const Box &box, const Inputs &inputs)
 {
     return CheckCollisionPointRec(inputs.mouse_point, box.rectangle);